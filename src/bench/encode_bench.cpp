@@ -0,0 +1,61 @@
+#include <chrono>
+#include <random>
+#include <iostream>
+#include <cstring>
+
+//headers
+#include "../encode.h"
+
+//microbenchmark of the ASCII to dna5 encoders: the former per-character push_back loop, the scalar table, and the vector kernels
+
+template <typename fn_t>
+double gbps(std::string const & s, fn_t && fn, int rounds)
+{
+	auto start = std::chrono::steady_clock::now();
+	for (int r = 0; r < rounds; ++r) fn();
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	return s.size() * static_cast<double>(rounds) / seconds / 1e9;
+};
+
+
+int main(int argc, char const ** argv)
+{
+	size_t n = (argc > 1) ? std::stoull(argv[1]) : 1 << 28;
+	int rounds = (argc > 2) ? std::stoi(argv[2]) : 5;
+
+	std::mt19937_64 rng(42);
+	std::string s(n, 'A');
+	char const letters[] = "ACGTACGTACGTACGTacgtNn";
+	for (char & c : s) c = letters[rng() % (sizeof(letters) - 1)];
+
+	std::vector<uint8_t> ranks(n), expected(n);
+	std::vector<seqan3::dna5> sequence;
+	size_t invalid = encode_ranks_scalar(s.data(), n, expected.data());
+
+	std::cout << "bases: " << n << ", rounds: " << rounds << std::endl;
+
+	std::cout << "push_back loop: " << gbps(s, [&]() {
+		sequence.clear();
+		for (char c : s) sequence.push_back(seqan3::assign_char_to(c, seqan3::dna5{}));
+	}, rounds) << " GB/s" << std::endl;
+
+	std::cout << "scalar table: " << gbps(s, [&]() { encode_ranks_scalar(s.data(), n, ranks.data()); }, rounds) << " GB/s" << std::endl;
+
+#ifdef CUBA_X86
+	if (__builtin_cpu_supports("sse4.1")) {
+
+		std::cout << "sse4.1: " << gbps(s, [&]() { encode_ranks_sse4(s.data(), n, ranks.data()); }, rounds) << " GB/s" << std::endl;
+		if (encode_ranks_sse4(s.data(), n, ranks.data()) != invalid || ranks != expected) std::cout << "sse4.1 output differs from scalar" << std::endl;
+	}
+
+	if (__builtin_cpu_supports("avx2")) {
+
+		std::cout << "avx2: " << gbps(s, [&]() { encode_ranks_avx2(s.data(), n, ranks.data()); }, rounds) << " GB/s" << std::endl;
+		if (encode_ranks_avx2(s.data(), n, ranks.data()) != invalid || ranks != expected) std::cout << "avx2 output differs from scalar" << std::endl;
+	}
+#endif
+
+	std::cout << "encode_dna5 (dispatched): " << gbps(s, [&]() { encode_dna5(s, sequence); }, rounds) << " GB/s" << std::endl;
+
+	return 0;
+}
@@ -0,0 +1,83 @@
+#include <chrono>
+#include <random>
+#include <iostream>
+
+//headers
+#include "../find.h"
+
+//per-query latency of exact search in find: the general seqan3 search against the lockstep engine (find -g),
+//one query at a time and in groups
+
+template <typename fn_t>
+double us_per_query(size_t nqueries, fn_t && fn)
+{
+	auto start = std::chrono::steady_clock::now();
+	fn();
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	return seconds * 1e6 / nqueries;
+};
+
+
+template <typename index_t>
+void bench(index_t const & indexin, std::vector<find_query> const & queries)
+{
+	size_t found = 0;
+	seqan3::configuration const cfg = seqan3::search_cfg::max_error_total{seqan3::search_cfg::error_count{0}} | seqan3::search_cfg::hit{seqan3::search_cfg::hit_all{}};
+
+	std::cout << "  seqan3 search: " << us_per_query(queries.size(), [&]() {
+		for (find_query const & q : queries) for (auto && hit : search(q.seq, indexin, cfg)) found += hit.reference_id() < queries.size();
+	}) << " us/query" << std::endl;
+
+	for (size_t group : {1, 32}) {
+
+		std::vector<lockstep_hit> hits;
+		std::cout << "  lockstep, group " << group << ": " << us_per_query(queries.size(), [&]() {
+			for (size_t i = 0; i < queries.size(); i += 256) {
+
+				hits.clear();
+				lockstep_search(indexin, queries, i, std::min(queries.size(), i + 256), group, hits);
+				found += hits.size();
+			}
+		}) << " us/query" << std::endl;
+	}
+
+	if (found == 0) std::cout << "  no hits" << std::endl;
+};
+
+
+int main(int argc, char const ** argv)
+{
+	size_t reflen = (argc > 1) ? std::stoull(argv[1]) : 1 << 22;
+	size_t nqueries = (argc > 2) ? std::stoull(argv[2]) : 10000;
+	size_t qlen = (argc > 3) ? std::stoull(argv[3]) : 30;
+
+	std::mt19937_64 rng(42);
+	std::vector<seqan3::dna5_vector> texts(4);
+
+	for (auto & text : texts) {
+
+		text.resize(reflen / texts.size());
+		for (auto & c : text) c = seqan3::assign_rank_to(rng() % 4, seqan3::dna5{});
+	}
+
+	std::vector<find_query> queries(nqueries);
+
+	for (find_query & q : queries) {
+
+		auto const & text = texts[rng() % texts.size()];
+		size_t p = rng() % (text.size() - qlen);
+		q.seq.assign(text.begin() + p, text.begin() + p + qlen);
+		if (rng() % 2) q.seq[rng() % qlen] = seqan3::assign_rank_to(rng() % 4, seqan3::dna5{}); //about half of them are not found
+	}
+
+	std::cout << "text: " << reflen << " bases, queries: " << nqueries << " x " << qlen << " bases" << std::endl;
+	std::cout << "fm-index" << std::endl;
+	seqan3::fm_index<seqan3::dna5, seqan3::text_layout::collection> fmi{texts};
+	bench(fmi, queries);
+
+	std::cout << "bidirectional fm-index" << std::endl;
+	seqan3::bi_fm_index<seqan3::dna5, seqan3::text_layout::collection> bifmi{texts};
+	bench(bifmi, queries);
+
+	return 0;
+}
@@ -0,0 +1,65 @@
+#include <chrono>
+#include <random>
+#include <memory>
+#include <iostream>
+
+//headers
+#include "../numa.h"
+
+//effect of -H transparent on index lookups, without an index: each query is a chain of dependent random reads over a large table,
+//as the rank lookups of a backward search are, where the next address is only known once the previous read is done.
+//The table is filled first and advised afterwards, as find does with a loaded index
+
+double queries_per_second(std::vector<std::pair<uintptr_t, uintptr_t>> const & before, size_t words, size_t nqueries, size_t qlen, bool advise)
+{
+	std::unique_ptr<uint64_t[]> table(new uint64_t[words]);
+	std::mt19937_64 rng(42);
+	for (size_t i = 0; i < words; ++i) table[i] = rng();
+
+	if (advise) {
+
+		size_t advised = advise_transparent_hugepages(before);
+		std::ifstream is{"/proc/self/smaps_rollup"};
+		std::string line, huge {"unknown"};
+		while (std::getline(is, line)) if (line.rfind("AnonHugePages:", 0) == 0) huge = line.substr(line.find_first_not_of(' ', 14));
+		std::cout << "  advised " << (advised >> 20) << " MB, backed by huge pages: " << huge << std::endl;
+	}
+
+	uint64_t state = 0;
+	auto start = std::chrono::steady_clock::now();
+
+	for (size_t q = 0; q < nqueries; ++q) {
+
+		uint64_t pos = rng() % words;
+		for (size_t i = 0; i < qlen; ++i) pos = (table[pos] ^ (pos * 0x9E3779B97F4A7C15ULL)) % words;
+		state += pos;
+	}
+
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	if (state == 0) std::cout << "  " << state << std::endl; //keep the chains alive
+	return nqueries / seconds;
+};
+
+
+int main(int argc, char const ** argv)
+{
+	size_t bytes = (argc > 1) ? std::stoull(argv[1]) : 1ULL << 31;
+	size_t nqueries = (argc > 2) ? std::stoull(argv[2]) : 1000000;
+	size_t qlen = (argc > 3) ? std::stoull(argv[3]) : 30;
+	int rounds = (argc > 4) ? std::stoi(argv[4]) : 3;
+
+	std::cout << "table: " << (bytes >> 20) << " MB, queries: " << nqueries << " x " << qlen << " dependent lookups" << std::endl;
+
+	for (int r = 0; r < rounds; ++r) {
+
+		for (bool advise : {false, true}) {
+
+			std::vector<std::pair<uintptr_t, uintptr_t>> before = anonymous_mappings();
+			std::cout << (advise ? "-H transparent" : "-H none") << std::endl;
+			double qps = queries_per_second(before, bytes / 8, nqueries, qlen, advise);
+			std::cout << "  " << static_cast<uint64_t>(qps) << " queries/s" << std::endl;
+		}
+	}
+
+	return 0;
+}
@@ -8,6 +8,7 @@
 #include "index.h"
 #include "find.h"
 #include "pwalign.h"
+#include "sketch.h"
 
 
 inline void asciiArt() {
@@ -32,7 +33,7 @@ int main(int argc, char const ** argv)
 											 argc,
 											 argv,
 											 seqan3::update_notifications::off,
-											 {"index", "find", "pwalign"}};
+											 {"index", "find", "pwalign", "sketch", "screen"}};
 
 	// Top level parser
 	top_level_parser.info.description.push_back("A collection of C++ modules based on ... to handle ... data efficiently");
@@ -77,6 +78,14 @@ int main(int argc, char const ** argv)
 	else if ( sub_parser.info.app_name == std::string_view{"cuba-pwalign"}) {
 		std::cout << "[Message][" <<  t << "] cuba align" << std::endl;
 		return pwalign(sub_parser);
-	}	
+	}
+	else if ( sub_parser.info.app_name == std::string_view{"cuba-sketch"}) {
+		std::cout << "[Message][" <<  t << "] cuba sketch" << std::endl;
+		return sketch(sub_parser);
+	}
+	else if ( sub_parser.info.app_name == std::string_view{"cuba-screen"}) {
+		std::cout << "[Message][" <<  t << "] cuba screen" << std::endl;
+		return screen(sub_parser);
+	}
 	return 0;
 }
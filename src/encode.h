@@ -0,0 +1,141 @@
+#ifndef ENCODE_H
+#define ENCODE_H
+
+#include <string_view>
+#include <vector>
+#include <seqan3/alphabet/all.hpp>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define CUBA_X86 1
+#endif
+
+//ASCII to dna5 ranks: A/a=0, C/c=1, G/g=2, T/t/U/u=3, N/n=4, as seqan3::assign_char_to does.
+//Anything else also becomes N, and is counted as invalid. The vector kernels are compiled for their own target and picked at runtime,
+//so the binary still runs on cpus without them
+
+using encode_fn = size_t (*)(char const *, size_t, uint8_t *);
+
+unsigned char const dna5_rank_table[256] = {
+	5, 5, 5, 5,  5, 5, 5, 5,  5, 5, 5, 5,  5, 5, 5, 5,
+	5, 5, 5, 5,  5, 5, 5, 5,  5, 5, 5, 5,  5, 5, 5, 5,
+	5, 5, 5, 5,  5, 5, 5, 5,  5, 5, 5, 5,  5, 5, 5, 5,
+	5, 5, 5, 5,  5, 5, 5, 5,  5, 5, 5, 5,  5, 5, 5, 5,
+	5, 0, 5, 1,  5, 5, 5, 2,  5, 5, 5, 5,  5, 5, 4, 5,
+	5, 5, 5, 5,  3, 3, 5, 5,  5, 5, 5, 5,  5, 5, 5, 5,
+	5, 0, 5, 1,  5, 5, 5, 2,  5, 5, 5, 5,  5, 5, 4, 5,
+	5, 5, 5, 5,  3, 3, 5, 5,  5, 5, 5, 5,  5, 5, 5, 5,
+	5, 5, 5, 5,  5, 5, 5, 5,  5, 5, 5, 5,  5, 5, 5, 5,
+	5, 5, 5, 5,  5, 5, 5, 5,  5, 5, 5, 5,  5, 5, 5, 5,
+	5, 5, 5, 5,  5, 5, 5, 5,  5, 5, 5, 5,  5, 5, 5, 5,
+	5, 5, 5, 5,  5, 5, 5, 5,  5, 5, 5, 5,  5, 5, 5, 5,
+	5, 5, 5, 5,  5, 5, 5, 5,  5, 5, 5, 5,  5, 5, 5, 5,
+	5, 5, 5, 5,  5, 5, 5, 5,  5, 5, 5, 5,  5, 5, 5, 5,
+	5, 5, 5, 5,  5, 5, 5, 5,  5, 5, 5, 5,  5, 5, 5, 5,
+	5, 5, 5, 5,  5, 5, 5, 5,  5, 5, 5, 5,  5, 5, 5, 5
+}; //5 marks an invalid character
+
+
+size_t encode_ranks_scalar(char const * in, size_t n, uint8_t * out)
+{
+	size_t invalid = 0;
+
+	for (size_t i = 0; i < n; ++i) {
+
+		uint8_t r = dna5_rank_table[static_cast<uint8_t>(in[i])];
+		invalid += (r == 5);
+		out[i] = r - (r == 5);
+	}
+
+	return invalid;
+};
+
+
+#ifdef CUBA_X86
+
+__attribute__((target("sse4.1")))
+size_t encode_ranks_sse4(char const * in, size_t n, uint8_t * out)
+{
+	__m128i const fold = _mm_set1_epi8(static_cast<char>(0xDF)); //clear the lowercase bit
+	__m128i const a = _mm_set1_epi8('A'), c = _mm_set1_epi8('C'), g = _mm_set1_epi8('G'), t = _mm_set1_epi8('T'), u = _mm_set1_epi8('U'), nn = _mm_set1_epi8('N');
+	__m128i const one = _mm_set1_epi8(1), two = _mm_set1_epi8(2), three = _mm_set1_epi8(3), four = _mm_set1_epi8(4);
+	size_t invalid = 0, i = 0;
+
+	for (; i + 16 <= n; i += 16) {
+
+		__m128i x = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<__m128i const *>(in + i)), fold);
+		__m128i isa = _mm_cmpeq_epi8(x, a), isc = _mm_cmpeq_epi8(x, c), isg = _mm_cmpeq_epi8(x, g);
+		__m128i ist = _mm_or_si128(_mm_cmpeq_epi8(x, t), _mm_cmpeq_epi8(x, u));
+		__m128i acgt = _mm_or_si128(_mm_or_si128(isa, isc), _mm_or_si128(isg, ist));
+		__m128i valid = _mm_or_si128(acgt, _mm_cmpeq_epi8(x, nn));
+
+		__m128i r = _mm_or_si128(_mm_or_si128(_mm_and_si128(isc, one), _mm_and_si128(isg, two)), _mm_and_si128(ist, three));
+		r = _mm_or_si128(r, _mm_andnot_si128(acgt, four));
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), r);
+		invalid += __builtin_popcount(~static_cast<unsigned>(_mm_movemask_epi8(valid)) & 0xFFFFu);
+	}
+
+	return invalid + encode_ranks_scalar(in + i, n - i, out + i);
+};
+
+
+__attribute__((target("avx2")))
+size_t encode_ranks_avx2(char const * in, size_t n, uint8_t * out)
+{
+	__m256i const fold = _mm256_set1_epi8(static_cast<char>(0xDF));
+	__m256i const a = _mm256_set1_epi8('A'), c = _mm256_set1_epi8('C'), g = _mm256_set1_epi8('G'), t = _mm256_set1_epi8('T'), u = _mm256_set1_epi8('U'), nn = _mm256_set1_epi8('N');
+	__m256i const one = _mm256_set1_epi8(1), two = _mm256_set1_epi8(2), three = _mm256_set1_epi8(3), four = _mm256_set1_epi8(4);
+	size_t invalid = 0, i = 0;
+
+	for (; i + 32 <= n; i += 32) {
+
+		__m256i x = _mm256_and_si256(_mm256_loadu_si256(reinterpret_cast<__m256i const *>(in + i)), fold);
+		__m256i isa = _mm256_cmpeq_epi8(x, a), isc = _mm256_cmpeq_epi8(x, c), isg = _mm256_cmpeq_epi8(x, g);
+		__m256i ist = _mm256_or_si256(_mm256_cmpeq_epi8(x, t), _mm256_cmpeq_epi8(x, u));
+		__m256i acgt = _mm256_or_si256(_mm256_or_si256(isa, isc), _mm256_or_si256(isg, ist));
+		__m256i valid = _mm256_or_si256(acgt, _mm256_cmpeq_epi8(x, nn));
+
+		__m256i r = _mm256_or_si256(_mm256_or_si256(_mm256_and_si256(isc, one), _mm256_and_si256(isg, two)), _mm256_and_si256(ist, three));
+		r = _mm256_or_si256(r, _mm256_andnot_si256(acgt, four));
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i), r);
+		invalid += __builtin_popcount(~static_cast<unsigned>(_mm256_movemask_epi8(valid)));
+	}
+
+	return invalid + encode_ranks_scalar(in + i, n - i, out + i);
+};
+
+#endif
+
+
+encode_fn select_encoder()
+{
+#ifdef CUBA_X86
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2")) return encode_ranks_avx2;
+	if (__builtin_cpu_supports("sse4.1")) return encode_ranks_sse4;
+#endif
+	return encode_ranks_scalar;
+};
+
+
+size_t encode_ranks(char const * in, size_t n, uint8_t * out)
+{
+
+	//write the dna5 ranks of in[0..n) to out[0..n), return the number of invalid characters
+
+	static encode_fn const encoder = select_encoder();
+	return encoder(in, n, out);
+};
+
+
+size_t encode_dna5(std::string_view s, std::vector<seqan3::dna5> & out)
+{
+
+	//replace out with the dna5 encoding of s, written in place: a dna5 letter is stored as its rank
+
+	static_assert(sizeof(seqan3::dna5) == 1, "dna5 is expected to be stored as a single rank byte");
+	out.resize(s.size());
+	return encode_ranks(s.data(), s.size(), reinterpret_cast<uint8_t *>(out.data()));
+};
+
+#endif
@@ -2,6 +2,11 @@
 #define FIND_H
 
 #include <filesystem>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <type_traits>
+#include <exception>
 #include <seqan3/argument_parser/all.hpp>
 #include <seqan3/core/debug_stream.hpp>
 #include <seqan3/search/fm_index/fm_index.hpp> //for using the fm_index
@@ -10,76 +15,550 @@
 #include <seqan3/search/search.hpp> //for searching
 #include <seqan3/alphabet/all.hpp>
 
+//headers
+#include "seqio.h"
+#include "numa.h"
+#include "lockstep.h"
+#include "smem.h"
+#include "encode.h"
+
 struct cmd_arguments_find {
 	std::string stringin;
 	std::string filein;
+	std::string fileout {"out.tsv"};
+	std::string hugepages {"none"};
+	std::string numa {"none"};
 	int maxerr {0};
+	int threads {1};
+	int group {0};
+	int minlen {19};
+	int maxocc {500};
 	bool bidirectional {true};
 	bool all {true};
+	bool queries {false};
+	bool smem {false};
+	bool bothstrands {false};
+};
+
+struct find_query {
+	std::string name;
+	std::vector<seqan3::dna5> seq;
+	char strand {'+'};
+	bool palindrome {false}; //equal to its reverse complement, searched once for both strands
 };
 
 
 void initialise_argument_parser_find(seqan3::argument_parser & subparser, cmd_arguments_find & args)
 {
 	subparser.info.description.push_back("Search for a string in a (bidirectional) fm-index");
-	subparser.add_positional_option(args.stringin, "input string to search for"); 
+	subparser.add_positional_option(args.stringin, "input string to search for (or fasta/fastq file of queries with -q/--queries)"); 
 	subparser.add_flag(args.bidirectional, 'b', "bidirectional", "the index is bidirectional (is a .bifmi file)",seqan3::option_spec::DEFAULT);
 	subparser.add_option(args.filein, 'f', "fmindex", "input (bi-)fm-index", seqan3::option_spec::REQUIRED);
 	subparser.add_option(args.maxerr, 'e', "error", "maximum number of errors for approximate search", seqan3::option_spec::DEFAULT);
 	subparser.add_flag(args.all, 'a', "all", "report all the hits",seqan3::option_spec::DEFAULT);
+	subparser.add_flag(args.queries, 'q', "queries", "input is a fasta/fastq file of queries, optionally gzip-compressed (batch search)",seqan3::option_spec::DEFAULT);
+	subparser.add_option(args.fileout, 'o', "output", "output tsv file (batch search)", seqan3::option_spec::DEFAULT);
+	subparser.add_option(args.threads, 't', "threads", "number of threads (batch search)", seqan3::option_spec::DEFAULT, seqan3::arithmetic_range_validator{1, 1024});
+	subparser.add_flag(args.bothstrands, 's', "both-strands", "search the query and its reverse complement. SMEM coordinates refer to the query as given, on either strand",seqan3::option_spec::DEFAULT);
+	subparser.add_flag(args.smem, 'S', "smem", "report the super-maximal exact matches of the query instead (requires -b/--bidirectional)",seqan3::option_spec::DEFAULT);
+	subparser.add_option(args.minlen, 'l', "min-length", "minimum length of a super-maximal exact match", seqan3::option_spec::DEFAULT, seqan3::arithmetic_range_validator{1, 1000000});
+	subparser.add_option(args.maxocc, 'c', "max-occ", "super-maximal exact matches with more occurrences than this (e.g. low-complexity sequence) are counted but not located. 0 for no limit", seqan3::option_spec::DEFAULT, seqan3::arithmetic_range_validator{0, 1000000000});
+	subparser.add_option(args.group, 'g', "group", "use the lockstep engine for exact search, advancing this many queries one symbol at a time. Experimental and not benchmarked: 0, the default, uses the general search", seqan3::option_spec::DEFAULT, seqan3::arithmetic_range_validator{0, 4096});
+	subparser.add_option(args.hugepages, 'H', "hugepages", "back the index with huge pages (batch search). Choose between none, transparent (advises the memory mapped while loading the index) or explicit (pages must be reserved in /proc/sys/vm/nr_hugepages, about the size of the index file per replica)", seqan3::option_spec::DEFAULT, seqan3::value_list_validator{"none", "transparent", "explicit"});
+	subparser.add_option(args.numa, 'n', "numa", "index placement on NUMA machines (batch search). Choose between none, interleave (spread over nodes) or replicate (one copy per node, threads pinned to their copy)", seqan3::option_spec::DEFAULT, seqan3::value_list_validator{"none", "interleave", "replicate"});
 };
 
 
-void bi_fmi_matcher(seqan3::bi_fm_index<seqan3::dna5, seqan3::text_layout::collection> & indexin, std::vector<seqan3::dna5> & query, auto & cfg)
+std::vector<seqan3::dna5> reverse_complement(std::vector<seqan3::dna5> const & seq)
 {
+	std::vector<seqan3::dna5> rc(seq.size());
 
-	//seqan3::debug_stream << search(query, indexin,cfg) << std::endl;
-	
+	for (size_t i = 0; i < seq.size(); ++i) {
+
+		uint8_t r = seqan3::to_rank(seq[seq.size() - 1 - i]);
+		rc[i] = seqan3::assign_rank_to(r < 4 ? 3 - r : r, seqan3::dna5{}); //N stays N
+	}
+
+	return rc;
+};
+
+
+std::vector<find_query> both_strands(std::vector<find_query> const & queries, size_t & palindromes)
+{
+
+	//each query followed by its reverse complement, unless they are the same sequence
+
+	std::vector<find_query> stranded;
+	stranded.reserve(2 * queries.size());
+
+	for (find_query const & query : queries) {
+
+		find_query rc {query.name, reverse_complement(query.seq), '-'};
+		stranded.push_back(query);
+
+		if (rc.seq == query.seq) {
+
+			stranded.back().palindrome = true;
+			++palindromes;
+
+		} else {
+
+			stranded.push_back(std::move(rc));
+
+		}
+	}
+
+	return stranded;
+};
+
+
+void append_hit(std::string & out, find_query const & query, bool bothstrands, std::string const & fields, std::string const & mirrored)
+{
+
+	//one tsv line per hit, with a strand column when searching both strands. A palindromic query's hits hold for both,
+	//mirrored are the fields of its - line
+
+	if (!bothstrands) {
+
+		out += query.name + "\t" + fields + "\n";
+		return;
+
+	}
+
+	out += query.name + "\t" + fields + "\t" + query.strand + "\n";
+	if (query.palindrome) out += query.name + "\t" + mirrored + "\t-\n";
+};
+
+
+std::pair<uint32_t, uint32_t> query_span(find_query const & query, uint32_t begin, uint32_t end)
+{
+
+	//1-based span of the forward query covered by query[begin..end), also when query is the reverse complement
+
+	if (query.strand == '-') return {query.seq.size() - end + 1, query.seq.size() - begin};
+	return {begin + 1, end};
+};
+
+
+void print_hits(std::vector<find_query> const & strands, std::vector<lockstep_hit> const & hits, bool bothstrands)
+{
+
+	//single query: its hits, strand by strand
+
+	time_t my_time; 
+	my_time= time(NULL);
+	char *t = ctime(&my_time);
+
+	for (size_t q = 0; q < strands.size(); ++q) {
+
+		if (bothstrands) {
+
+			t = ctime(&my_time);
+			t[strlen(t)-1] = '\0';
+			std::cout << "[Message][" <<  t << "] Strand " << strands[q].strand << (strands[q].palindrome ? " (the query is its own reverse complement, hits hold for both strands)" : "") << std::endl;
+		}
+
+		int counter=0;
+
+		for (lockstep_hit const & hit : hits) {
+
+			if (hit.query != q) continue;
+			seqan3::debug_stream << "Hit found on sequence " << hit.reference + 1 << ", starting at base " << hit.position + 1  << std::endl;
+			counter ++;
+		}
+
+		if (counter == 0) {
+
+			std::cout << "No hit found" << std::endl;
+
+		}
+	}
+
+};
+
+
+void bi_fmi_smem(seqan3::bi_fm_index<seqan3::dna5, seqan3::text_layout::collection> const & indexin, find_query const & query, uint32_t minlen, size_t maxocc)
+{
+
+	std::vector<smem_match<decltype(indexin.cursor())>> matches;
+	smem_search(indexin, query.seq, minlen, matches);
 
-	auto search_results = search(query, indexin, cfg);
+	for (auto const & match : matches) {
 
-	//std::cout << "Found " << search_results.size() << " matches" >> std::endl;
+		auto [begin, end] = query_span(query, match.begin, match.end);
 
-	int counter=0;
+		if (maxocc > 0 && match.cursor.count() > maxocc) {
 
-	for (auto && hit : search_results) {
+			seqan3::debug_stream << "SMEM " << begin << "-" << end << " has " << match.cursor.count() << " occurrences, not located (above -c/--max-occ)" << std::endl;
+			continue;
+		}
+
+		for (auto && [reference, position] : match.cursor.locate()) {
+
+			seqan3::debug_stream << "SMEM " << begin << "-" << end << " found on sequence " << reference + 1 << ", starting at base " << position + 1 << std::endl;
+		}
+	}
+
+	if (matches.empty()) {
+
+		std::cout << "No SMEM found" << std::endl;
 
-		seqan3::debug_stream << "Hit found on sequence " << hit.reference_id() +1 << ", starting at base " << hit.reference_begin_position() +1  << std::endl;
-		counter ++;
 	}
 
-	if (counter == 0) {
+};
+
+
+std::vector<find_query> load_queries(std::string const & file)
+{
+	gzFile fp;
+	kseq_t *seq;
+	std::vector<find_query> queries;
+
+	fp = gzopen(file.c_str(), "r");
+	seq = kseq_init(fp);
+
+	while (kseq_read(seq) >= 0) {
+
+		find_query query {};
+		query.name = seq->name.s;
+		encode_dna5(std::string_view(seq->seq.s, seq->seq.l), query.seq); //fill vector seq
+		queries.push_back(std::move(query));
+	}
+
+	kseq_destroy(seq);
+	gzclose(fp);
+
+	return queries;
+};
+
+
+template <typename index_t>
+void load_index(std::string const & fin, index_t & indexin)
+{
+	std::ifstream is{fin, std::ios::binary};
+	cereal::BinaryInputArchive iarchive{is};
+	iarchive(indexin);
+};
+
+
+template <typename index_t>
+void load_replicas(cmd_arguments_find const & args, std::string const & fin, std::vector<int> const & nodes, std::vector<index_t> & replicas)
+{
+
+	//one replica: loaded here, interleaved across nodes if asked. More replicas: each copy is read by a thread pinned to its node,
+	//so that first-touch places it in that node's memory. The sdsl huge page pool is not thread-safe, in that case copies are loaded
+	//one after the other. Loading errors are rethrown to the caller
+
+	if (replicas.size() == 1) {
+
+		if (args.numa == "interleave" && !set_interleave_policy(nodes)) {
+
+			time_t my_time = time(NULL);
+			char *t = ctime(&my_time);
+			t[strlen(t)-1] = '\0';
+			std::cout << "[Warning][" <<  t << "] Could not interleave the index across NUMA nodes" << std::endl;
+		}
+
+		try
+		{
+			load_index(fin, replicas[0]);
+		}
+
+		catch (...)
+		{
+			if (args.numa == "interleave") reset_memory_policy();
+			throw;
+		}
+
+		if (args.numa == "interleave") reset_memory_policy();
+		return;
+	}
+
+	std::vector<std::thread> loaders;
+	std::vector<std::exception_ptr> failures(replicas.size());
+
+	for (size_t n = 0; n < replicas.size(); ++n) {
+
+		loaders.emplace_back([&, n]() {
+
+			pin_thread_to_node(nodes[n]);
+
+			try
+			{
+				load_index(fin, replicas[n]);
+			}
+
+			catch (...)
+			{
+				failures[n] = std::current_exception();
+			}
+		});
+
+		if (args.hugepages == "explicit") loaders.back().join();
+	}
+
+	for (auto & th : loaders) if (th.joinable()) th.join();
+	for (auto & failure : failures) if (failure) std::rethrow_exception(failure);
+};
+
+
+template <typename index_t, typename config_t>
+void search_hits(index_t const & indexin, std::vector<find_query> const & queries, size_t begin, size_t end, config_t const & cfg, std::vector<lockstep_hit> & hits)
+{
+
+	//general seqan3 search of queries[begin..end)
 
-		std::cout << "No hit found" << std::endl;
+	for (size_t q = begin; q < end; ++q) for (auto && hit : search(queries[q].seq, indexin, cfg)) hits.push_back(lockstep_hit{q, hit.reference_id(), hit.reference_begin_position()});
+};
+
+
+template <typename index_t>
+void lockstep_hits(index_t const & indexin, std::vector<find_query> const & queries, size_t begin, size_t end, cmd_arguments_find const & args, std::vector<lockstep_hit> & hits)
+{
+	lockstep_search(indexin, queries, begin, end, args.group, hits);
+};
+
+
+template <typename index_t>
+void smem_chunk(index_t const & indexin, std::vector<find_query> const & queries, size_t begin, size_t end, cmd_arguments_find const & args, std::string & out, size_t & repetitive)
+{
 
+	//SMEMs with more than args.maxocc occurrences are only counted in repetitive: locating them all is what a poly-A
+	//or a satellite would cost
+
+	std::vector<smem_match<decltype(indexin.cursor())>> matches;
+
+	for (size_t i = begin; i < end; ++i) {
+
+		matches.clear();
+		smem_search(indexin, queries[i].seq, args.minlen, matches);
+
+		for (auto const & match : matches) {
+
+			if (args.maxocc > 0 && match.cursor.count() > static_cast<size_t>(args.maxocc)) { ++repetitive; continue; }
+			auto [qbegin, qend] = query_span(queries[i], match.begin, match.end);
+			auto [mbegin, mend] = query_span(find_query{"", queries[i].seq, '-'}, match.begin, match.end); //the same match, read on the - strand
+
+			for (auto && [reference, position] : match.cursor.locate()) {
+
+				std::string hit = "\t" + std::to_string(reference + 1) + "\t" + std::to_string(position + 1);
+				append_hit(out, queries[i], args.bothstrands, std::to_string(qbegin) + "\t" + std::to_string(qend) + hit, std::to_string(mbegin) + "\t" + std::to_string(mend) + hit);
+			}
+		}
 	}
+};
+
+
+template <typename index_t>
+using chunk_engine = void (*)(index_t const &, std::vector<find_query> const &, size_t, size_t, cmd_arguments_find const &, std::vector<lockstep_hit> &);
+
 
+template <typename index_t>
+chunk_engine<index_t> select_chunk_engine(cmd_arguments_find const & args)
+{
+
+	//nullptr for the general seqan3 search: the lockstep engine only replaces exact search, and only when -g asks for it
+
+	if (args.group == 0 || args.maxerr != 0) return nullptr;
+	return lockstep_hits<index_t>;
 };
 
 
+template <typename index_t, typename config_t>
+void find_single(cmd_arguments_find const & args, index_t const & indexin, std::vector<seqan3::dna5> const & sequence, config_t const & cfg)
+{
+
+	//search the query, and its reverse complement unless the two are the same, with the same engines as batch search
+
+	size_t palindromes = 0;
+	std::vector<find_query> strands {find_query{"", sequence}};
+	if (args.bothstrands) strands = both_strands(strands, palindromes);
+
+	if constexpr (std::is_same_v<index_t, seqan3::bi_fm_index<seqan3::dna5, seqan3::text_layout::collection>>) {
+
+		if (args.smem) {
+
+			time_t my_time; 
+			my_time= time(NULL);
+			char *t = ctime(&my_time);
+
+			//a palindromic query is also reported as its - strand, where the same SMEMs cover the mirrored span of the query
+
+			if (!strands.empty() && strands[0].palindrome) strands.push_back(find_query{"", strands[0].seq, '-', true});
 
+			for (find_query const & query : strands) {
 
-void fmi_matcher(seqan3::fm_index<seqan3::dna5, seqan3::text_layout::collection> & indexin, std::vector<seqan3::dna5> & query, auto & cfg)
+				if (args.bothstrands) {
+
+					t = ctime(&my_time);
+					t[strlen(t)-1] = '\0';
+					std::cout << "[Message][" <<  t << "] Strand " << query.strand << (query.palindrome ? " (the query is its own reverse complement)" : "") << std::endl;
+				}
+
+				bi_fmi_smem(indexin, query, args.minlen, args.maxocc);
+			}
+
+			return;
+		}
+	}
+
+	std::vector<lockstep_hit> hits;
+	chunk_engine<index_t> engine = select_chunk_engine<index_t>(args);
+	if (engine) engine(indexin, strands, 0, strands.size(), args, hits);
+	else search_hits(indexin, strands, 0, strands.size(), cfg, hits);
+	print_hits(strands, hits, args.bothstrands);
+};
+
+
+template <typename index_t, typename config_t>
+int find_batch(cmd_arguments_find & args, std::string const & fin, config_t const & cfg)
 {
 
-	auto search_results = search(query, indexin, cfg);
+	time_t my_time; 
+	my_time= time(NULL);
+	char *t = ctime(&my_time);
+
+	t = ctime(&my_time);
+	t[strlen(t)-1] = '\0';
+	std::cout << "[Message][" <<  t << "] Loading queries" << std::endl;
+	std::vector<find_query> queries = load_queries(std::filesystem::canonical(args.stringin).string());
+
+	if (args.bothstrands) {
+
+		size_t palindromes = 0;
+		queries = both_strands(queries, palindromes);
+
+		t = ctime(&my_time);
+		t[strlen(t)-1] = '\0';
+		std::cout << "[Message][" <<  t << "] Added reverse complements, " << palindromes << " palindromic queries are searched once" << std::endl;
+	}
+
+	std::vector<int> nodes = numa_nodes();
+	bool replicate = args.numa == "replicate" && nodes.size() > 1;
+	std::vector<index_t> replicas(replicate ? nodes.size() : 1);
+	bool hugepages = false;
+
+	if (args.hugepages == "explicit") {
+
+		//the serialized sdsl vectors are their in-memory size, so the file size sizes the pool. The slack covers the allocator
+		//bookkeeping and alignment
+
+		std::string error;
+		size_t bytes = std::filesystem::file_size(fin) * replicas.size();
+		bytes += bytes / 16 + (64 << 20);
+		hugepages = use_explicit_hugepages(bytes, error);
+
+		if (!hugepages) {
+
+			t = ctime(&my_time);
+			t[strlen(t)-1] = '\0';
+			std::cout << "[Warning][" <<  t << "] Could not reserve " << bytes << " bytes of huge pages (" << error << "). Using regular pages" << std::endl;
+		}
+	}
+
+	t = ctime(&my_time);
+	t[strlen(t)-1] = '\0';
+	std::cout << "[Message][" <<  t << "] Loading index (" << replicas.size() << " replica/s over " << nodes.size() << " NUMA node/s)" << std::endl;
+	std::vector<std::pair<uintptr_t, uintptr_t>> before = anonymous_mappings();
 
-	//std::cout << "Found " << search_results.size() << " matches" >> std::endl;
+	try
+	{
+		load_replicas(args, fin, nodes, replicas);
+	}
 
-	int counter=0;
+	catch (std::exception const & ext)
+	{
+		if (!hugepages) throw;
 
-	for (auto && hit : search_results) {
+		//sdsl cannot go back to regular pages once the pool is in use
 
-		seqan3::debug_stream << "Hit found on sequence " << hit.reference_id() +1 << ", starting at base " << hit.reference_begin_position() +1  << std::endl;
-		counter ++;
+		t = ctime(&my_time);
+		t[strlen(t)-1] = '\0';
+		std::cout << "[Error][" <<  t << "] The huge page pool ran out while loading the index (" << ext.what() << "). Reserve more pages in /proc/sys/vm/nr_hugepages or use -H none/transparent" << std::endl;
+		return -1;
 	}
 
-	if (counter == 0) {
+	if (args.hugepages == "transparent") {
 
-		std::cout << "No hit found" << std::endl;
+		size_t advised = advise_transparent_hugepages(before);
+		t = ctime(&my_time);
+		t[strlen(t)-1] = '\0';
+		std::cout << "[Message][" <<  t << "] Requested transparent huge pages for " << (advised >> 20) << " MB" << std::endl;
+	}
 
+	t = ctime(&my_time);
+	t[strlen(t)-1] = '\0';
+	std::cout << "[Message][" <<  t << "] Searching " << queries.size() << " queries with " << args.threads << " thread/s" << std::endl;
+
+	size_t const chunksize = std::max(256, args.group);
+	size_t nchunks = (queries.size() + chunksize - 1) / chunksize;
+	std::vector<std::string> results(nchunks);
+	std::atomic<size_t> next {0};
+	std::vector<std::thread> workers;
+	std::atomic<size_t> repetitive {0};
+	chunk_engine<index_t> engine = select_chunk_engine<index_t>(args);
+
+	auto start = std::chrono::steady_clock::now();
+
+	for (int w = 0; w < args.threads; ++w) {
+
+		workers.emplace_back([&, w]() {
+
+			if (args.numa != "none") pin_thread_to_node(nodes[w % nodes.size()]);
+			index_t const & indexin = replicas[replicate ? w % nodes.size() : 0];
+			std::vector<lockstep_hit> hits;
+			size_t skipped = 0;
+
+			for (size_t c = next++; c < nchunks; c = next++) {
+
+				size_t begin = c * chunksize, end = std::min(queries.size(), begin + chunksize);
+
+				if constexpr (std::is_same_v<index_t, seqan3::bi_fm_index<seqan3::dna5, seqan3::text_layout::collection>>) {
+
+					if (args.smem) { smem_chunk(indexin, queries, begin, end, args, results[c], skipped); continue; }
+				}
+
+				hits.clear();
+				if (engine) engine(indexin, queries, begin, end, args, hits);
+				else search_hits(indexin, queries, begin, end, cfg, hits);
+
+				for (lockstep_hit const & hit : hits) {
+
+					std::string fields = std::to_string(hit.reference + 1) + "\t" + std::to_string(hit.position + 1);
+					append_hit(results[c], queries[hit.query], args.bothstrands, fields, fields);
+				}
+			}
+
+			repetitive += skipped;
+		});
 	}
 
+	for (auto & th : workers) th.join();
+
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	std::string fout = std::filesystem::absolute(std::filesystem::weakly_canonical(args.fileout).string()).string();
+	std::ofstream os{fout};
+	os << (args.smem ? "query\tquery_begin\tquery_end\tsequence\tposition" : "query\tsequence\tposition") << (args.bothstrands ? "\tstrand\n" : "\n");
+	for (std::string const & r : results) os << r;
+
+	if (repetitive > 0) {
+
+		t = ctime(&my_time);
+		t[strlen(t)-1] = '\0';
+		std::cout << "[Message][" <<  t << "] " << repetitive << " super-maximal exact match/es with more than " << args.maxocc << " occurrences were not located (-c/--max-occ)" << std::endl;
+	}
+
+	t = ctime(&my_time);
+	t[strlen(t)-1] = '\0';
+	std::cout << "[Message][" <<  t << "] Searched " << queries.size() << " queries in " << seconds << " s (" << static_cast<uint64_t>(queries.size() / std::max(seconds, 1e-9)) << " queries/s). Results written to " << fout << std::endl;
+
+	t = ctime(&my_time);
+	t[strlen(t)-1] = '\0';
+	std::cout << "[Message][" <<  t << "] Done" << std::endl;
+
+	return 0;
+
 };
 
 
@@ -108,6 +587,23 @@ int find(seqan3::argument_parser & subparser)
 		return -1;
 	}
 
+	if (args.smem && !args.bidirectional) {
+
+		t = ctime(&my_time);
+		t[strlen(t)-1] = '\0';
+		std::cout << "[Error][" <<  t << "] Searching for super-maximal exact matches requires a bidirectional fm-index (-b/--bidirectional)" << std::endl;
+		return -1;
+
+	}
+
+	if (!args.queries && (args.hugepages != "none" || args.numa != "none")) {
+
+		t = ctime(&my_time);
+		t[strlen(t)-1] = '\0';
+		std::cout << "[Warning][" <<  t << "] -H/--hugepages and -n/--numa only apply to batch search (-q/--queries), ignoring them" << std::endl;
+
+	}
+
 	std::vector<seqan3::dna5> sequence {};
 	std::string fin;
 
@@ -133,18 +629,20 @@ int find(seqan3::argument_parser & subparser)
 		
 		} // extension is wrong, stop
 
+		if (args.queries) return find_batch<seqan3::bi_fm_index<seqan3::dna5, seqan3::text_layout::collection>>(args, fin, cfg);
+
 		{
 		std::ifstream is{fin, std::ios::binary};
 		cereal::BinaryInputArchive iarchive{is};
 		iarchive(indexin);
 		}
 
-		for (char c : args.stringin) sequence.push_back(seqan3::assign_char_to(c, seqan3::dna5{})); //fill vector seq
+		encode_dna5(args.stringin, sequence); //fill vector seq
 
 		t = ctime(&my_time);
 		t[strlen(t)-1] = '\0';
 		std::cout << "[Message][" <<  t << "] Searching through the bidirectional fm-index" << std::endl;
-		bi_fmi_matcher(indexin, sequence,cfg);
+		find_single(args, indexin, sequence, cfg);
 
 
 	
@@ -166,17 +664,19 @@ int find(seqan3::argument_parser & subparser)
 		
 		} // extension is wrong, stop
 
+		if (args.queries) return find_batch<seqan3::fm_index<seqan3::dna5, seqan3::text_layout::collection>>(args, fin, cfg);
+
 		{
 		std::ifstream is{fin, std::ios::binary};
 		cereal::BinaryInputArchive iarchive{is};
 		iarchive(indexin);
 		}
 
-		for (char c : args.stringin) sequence.push_back(seqan3::assign_char_to(c, seqan3::dna5{})); //fill vector seq
+		encode_dna5(args.stringin, sequence); //fill vector seq
 		t = ctime(&my_time);
 		t[strlen(t)-1] = '\0';
 		std::cout << "[Message][" <<  t << "] Searching through the fm-index" << std::endl;
-		fmi_matcher(indexin, sequence, cfg);
+		find_single(args, indexin, sequence, cfg);
 
 	}
 
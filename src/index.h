@@ -16,7 +16,8 @@
 #include <seqan3/alphabet/all.hpp>
 
 //headers
-#include "kseq.h"
+#include "seqio.h"
+#include "encode.h"
 
 struct cmd_arguments_index {
 	std::vector<std::string> filein{};
@@ -26,8 +27,6 @@ struct cmd_arguments_index {
 };
 
 
-KSEQ_INIT(gzFile, gzread)
-
 void initialise_argument_parser_index(seqan3::argument_parser & subparser, cmd_arguments_index & args)
 {
 	subparser.info.description.push_back("Create a full-searchable (bidirectional) fm-index from fasta/fastq file/s");
@@ -64,6 +63,7 @@ int index(seqan3::argument_parser & subparser)
 	gzFile fp;
 	kseq_t *seq;
 	int l;
+	size_t invalid = 0;
 	std::vector<seqan3::dna5_vector> sequences = {};
 	std::string fmout = std::filesystem::absolute(std::filesystem::weakly_canonical(args.fileout).string()).string();
 	std::string tmpfile;
@@ -83,7 +83,6 @@ int index(seqan3::argument_parser & subparser)
 
 			std::vector<seqan3::dna5> sequence {};
 			n=seq->name.s;
-			s=seq->seq.s;
 			
 			//if (seq->qual.l) { //is fastq
 
@@ -91,8 +90,8 @@ int index(seqan3::argument_parser & subparser)
 				//q=seq->qual.s;
 			//} //this is not used for the time being, but we can add here filters based on quality
 
-			for (char c : s) sequence.push_back(seqan3::assign_char_to(c, seqan3::dna5{})); //fill vector seq
-			sequences.push_back(sequence);
+			invalid += encode_dna5(std::string_view(seq->seq.s, seq->seq.l), sequence); //fill vector seq
+			sequences.push_back(std::move(sequence));
 		}
 
 		gzclose(fp);
@@ -101,6 +100,14 @@ int index(seqan3::argument_parser & subparser)
 
 	kseq_destroy(seq);
 
+	if (invalid) {
+
+		t = ctime(&my_time);
+		t[strlen(t)-1] = '\0';
+		std::cout << "[Warning][" <<  t << "] " << invalid << " invalid character/s were stored as N" << std::endl;
+
+	}
+
 	if (!tmpfile.empty()) {
 
 		t = ctime(&my_time);
@@ -0,0 +1,78 @@
+#ifndef LOCKSTEP_H
+#define LOCKSTEP_H
+
+#include <vector>
+#include <tuple>
+#include <algorithm>
+#include <seqan3/alphabet/all.hpp>
+
+//batched backward search: a group of queries is advanced one symbol per round instead of running each query to completion.
+//Each extension is still a full rank through seqan3's cursor, which keeps its interval private, so nothing is prefetched ahead of it.
+//Exact search only, opt-in (find -g) until find_bench shows it winning over the general search.
+
+struct lockstep_hit {
+	size_t query;
+	uint64_t reference;
+	uint64_t position;
+
+	bool operator<(lockstep_hit const & other) const
+	{
+		return std::tie(query, reference, position) < std::tie(other.query, other.reference, other.position);
+	}
+};
+
+template <typename cursor_t>
+struct lockstep_state {
+	cursor_t cursor;
+	size_t query;
+	uint32_t pos; //next query symbol to consume
+};
+
+
+template <typename index_t, typename query_t>
+void lockstep_search(index_t const & indexin, std::vector<query_t> const & queries, size_t begin, size_t end, size_t group, std::vector<lockstep_hit> & hits)
+{
+
+	//exact search of queries[begin..end), group queries at a time, one cursor per query dropped as soon as it fails.
+	//Hits are sorted by query, reference and position
+
+	using cursor_t = decltype(indexin.cursor());
+	std::vector<lockstep_state<cursor_t>> frontier;
+	size_t first = hits.size();
+
+	for (size_t g = begin; g < end; g += group) {
+
+		frontier.clear();
+		for (size_t q = g; q < std::min(end, g + group); ++q) frontier.push_back(lockstep_state<cursor_t>{indexin.cursor(), q, 0});
+
+		while (!frontier.empty()) {
+
+			size_t kept = 0;
+
+			for (size_t i = 0; i < frontier.size(); ++i) {
+
+				lockstep_state<cursor_t> & s = frontier[i];
+				auto const & query = queries[s.query].seq;
+
+				if (s.pos == query.size()) {
+
+					if (s.pos > 0) for (auto && [reference, position] : s.cursor.locate()) hits.push_back(lockstep_hit{s.query, reference, position});
+					continue;
+				}
+
+				if (s.cursor.extend_right(query[s.pos])) {
+
+					++s.pos;
+					if (kept != i) frontier[kept] = s;
+					++kept;
+				}
+			}
+
+			frontier.erase(frontier.begin() + kept, frontier.end());
+		}
+	}
+
+	std::sort(hits.begin() + first, hits.end());
+};
+
+#endif
@@ -0,0 +1,197 @@
+#ifndef NUMA_H
+#define NUMA_H
+
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <string>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <system_error>
+#include <sdsl/memory_management.hpp>
+
+//no dependency on libnuma: topology comes from sysfs and memory policies are set through the raw syscall
+
+#ifndef MPOL_DEFAULT
+#define MPOL_DEFAULT 0
+#endif
+#ifndef MPOL_INTERLEAVE
+#define MPOL_INTERLEAVE 3
+#endif
+#ifndef MADV_COLLAPSE
+#define MADV_COLLAPSE 25 //linux 6.1, older kernels reject it and the pages are left to khugepaged
+#endif
+
+
+std::vector<int> parse_cpulist(std::string const & list)
+{
+
+	//parse a sysfs list such as "0-15,32-47"
+
+	std::vector<int> ids;
+	std::stringstream ss(list);
+	std::string range;
+
+	while (std::getline(ss, range, ',')) {
+
+		if (range.empty() || range == "\n") continue;
+		size_t dash = range.find('-');
+		int first = std::stoi(range.substr(0, dash));
+		int last = (dash == std::string::npos) ? first : std::stoi(range.substr(dash + 1));
+		for (int i = first; i <= last; ++i) ids.push_back(i);
+	}
+
+	return ids;
+};
+
+
+std::vector<int> numa_nodes()
+{
+
+	//online NUMA nodes. A single node 0 if the machine (or the kernel) does not expose any
+
+	std::ifstream is{"/sys/devices/system/node/online"};
+	std::string list;
+	if (!is || !std::getline(is, list)) return {0};
+	std::vector<int> nodes = parse_cpulist(list);
+	if (nodes.empty()) nodes.push_back(0);
+	return nodes;
+};
+
+
+std::vector<int> numa_node_cpus(int node)
+{
+	std::ifstream is{"/sys/devices/system/node/node" + std::to_string(node) + "/cpulist"};
+	std::string list;
+	if (!is || !std::getline(is, list)) return {};
+	return parse_cpulist(list);
+};
+
+
+bool pin_thread_to_node(int node)
+{
+
+	//restrict the calling thread to the cpus of a node. With the default first-touch policy, memory it then writes is node-local
+
+	std::vector<int> cpus = numa_node_cpus(node);
+	if (cpus.empty()) return false;
+
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	for (int c : cpus) if (c < CPU_SETSIZE) CPU_SET(c, &set);
+	return pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &set) == 0;
+};
+
+
+bool set_interleave_policy(std::vector<int> const & nodes)
+{
+
+	//pages the calling thread allocates from now on are spread round-robin over nodes
+
+	unsigned long mask[16] = {0};
+
+	for (int n : nodes) {
+
+		if (n < 0 || n >= static_cast<int>(sizeof(mask) * 8)) return false;
+		mask[n / (sizeof(unsigned long) * 8)] |= 1UL << (n % (sizeof(unsigned long) * 8));
+	}
+
+	return syscall(SYS_set_mempolicy, MPOL_INTERLEAVE, mask, sizeof(mask) * 8 + 1) == 0;
+};
+
+
+void reset_memory_policy()
+{
+	syscall(SYS_set_mempolicy, MPOL_DEFAULT, NULL, 0);
+};
+
+
+bool use_explicit_hugepages(size_t bytes, std::string & error)
+{
+
+	//serve all the following sdsl allocations (the index bit vectors) from a pool of hugetlbfs pages.
+	//Needs pages reserved beforehand, e.g. echo N > /proc/sys/vm/nr_hugepages
+
+	try
+	{
+		sdsl::memory_manager::use_hugepages(bytes);
+	}
+
+	catch (std::system_error const & ext)
+	{
+		error = ext.what();
+		return false;
+	}
+
+	return true;
+};
+
+
+std::vector<std::pair<uintptr_t, uintptr_t>> anonymous_mappings()
+{
+
+	//address ranges of the anonymous writable mappings of the process (heap included), in increasing order
+
+	std::ifstream is{"/proc/self/maps"};
+	std::string line;
+	std::vector<std::pair<uintptr_t, uintptr_t>> ranges;
+
+	while (std::getline(is, line)) {
+
+		std::stringstream ss(line);
+		std::string range, perms, offset, dev, inode, path;
+		ss >> range >> perms >> offset >> dev >> inode >> path;
+		if (perms.size() < 2 || perms[0] != 'r' || perms[1] != 'w' || inode != "0") continue; //anonymous, writable
+		if (!path.empty() && path != "[heap]") continue;
+
+		size_t dash = range.find('-');
+		ranges.emplace_back(std::stoull(range.substr(0, dash), nullptr, 16), std::stoull(range.substr(dash + 1), nullptr, 16));
+	}
+
+	return ranges;
+};
+
+
+size_t advise_transparent_hugepages(std::vector<std::pair<uintptr_t, uintptr_t>> const & before)
+{
+
+	//ask for transparent huge pages on the anonymous memory mapped since before was taken (a snapshot right before loading the index,
+	//so that queries, stacks and the rest of the heap are left alone), and collapse it right away when the kernel supports it
+	//rather than waiting for khugepaged. Returns the number of bytes advised
+
+	size_t advised = 0;
+	size_t const hugepage = 2 << 20;
+
+	auto advise = [&](uintptr_t begin, uintptr_t end) {
+
+		begin = (begin + hugepage - 1) & ~(hugepage - 1);
+		end &= ~(hugepage - 1);
+		if (end <= begin) return;
+
+		if (madvise(reinterpret_cast<void *>(begin), end - begin, MADV_HUGEPAGE) != 0) return;
+		madvise(reinterpret_cast<void *>(begin), end - begin, MADV_COLLAPSE);
+		advised += end - begin;
+	};
+
+	for (auto [begin, end] : anonymous_mappings()) {
+
+		for (auto [oldbegin, oldend] : before) { //advise the gaps left by the old mappings
+
+			if (oldend <= begin) continue;
+			if (oldbegin >= end) break;
+			if (oldbegin > begin) advise(begin, oldbegin);
+			begin = std::max(begin, oldend);
+		}
+
+		if (begin < end) advise(begin, end);
+	}
+
+	return advised;
+};
+
+#endif
@@ -2,6 +2,13 @@
 #define PWALIGN_H
 
 #include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <deque>
+#include <limits>
+#include <algorithm>
 #include <seqan3/argument_parser/all.hpp>
 #include <seqan3/core/debug_stream.hpp>
 #include <seqan3/alphabet/all.hpp>
@@ -10,6 +17,10 @@
 #include <seqan3/alignment/scoring/nucleotide_scoring_scheme.hpp>
 #include <seqan3/alignment/configuration/align_config_gap_cost_affine.hpp>
 
+//headers
+#include "seqio.h"
+#include "encode.h"
+
 
 struct cmd_arguments_pwalign {
 	std::vector<std::string> stringin{};
@@ -18,18 +29,238 @@ struct cmd_arguments_pwalign {
 	int mismatch{-3};
 	int gapopen{-4};
 	int gapextend{-2};
+	bool allvsall{false};
+	std::string fileout{"out.tsv"};
+	int threads{1};
+	int minscore{std::numeric_limits<int>::min()};
+	int kmer{0};
+	int minshared{1};
+	int tile{64};
+};
+
+struct tile_pool {
+
+	//work-stealing scheduler for the all-vs-all tiles. Each worker pops from the back of its own deque and, once that is empty,
+	//steals from the front of the others', so that tiles emptied by the prefilter do not leave threads idle
+
+	std::vector<std::deque<size_t>> queues;
+	std::vector<std::mutex> locks;
+
+	tile_pool(size_t workers, size_t tasks) : queues(workers), locks(workers)
+	{
+		for (size_t i = 0; i < tasks; ++i) queues[i % workers].push_back(i);
+	}
+
+	bool pop(size_t worker, size_t & task)
+	{
+		{
+		std::lock_guard<std::mutex> lock(locks[worker]);
+
+		if (!queues[worker].empty()) {
+
+			task = queues[worker].back();
+			queues[worker].pop_back();
+			return true;
+		}
+		}
+
+		for (size_t i = 1; i < queues.size(); ++i) {
+
+			size_t victim = (worker + i) % queues.size();
+			std::lock_guard<std::mutex> lock(locks[victim]);
+
+			if (!queues[victim].empty()) {
+
+				task = queues[victim].front();
+				queues[victim].pop_front();
+				return true;
+			}
+		}
+
+		return false; //tasks are never added once started, so every queue is drained
+	}
 };
 
 
 void initialise_argument_parser_pwalign(seqan3::argument_parser & subparser, cmd_arguments_pwalign & args)
 {
-	subparser.info.description.push_back("Perform pairwise alignment between a couple of strings");
-	subparser.add_positional_option(args.stringin, "a couple of strings");
+	subparser.info.description.push_back("Perform pairwise alignment between a couple of strings, or between all the sequences in a fasta/fastq file");
+	subparser.add_positional_option(args.stringin, "a couple of strings (or a fasta/fastq file with -A/--all-vs-all)");
 	subparser.add_option(args.type, 'a', "alignment", "Alignment type. Choose between global or local.", seqan3::option_spec::DEFAULT, seqan3::value_list_validator{"global", "local"});
 	subparser.add_option(args.match, 'm', "match", "Reward for a matching base", seqan3::option_spec::DEFAULT);
 	subparser.add_option(args.mismatch, 'x', "mismatch", "Penalty for a mismatching base", seqan3::option_spec::DEFAULT);
 	subparser.add_option(args.gapopen, 'g', "gapopen", "Penalty for opening a gap", seqan3::option_spec::DEFAULT);
 	subparser.add_option(args.gapextend, 'e', "gapextend", "Penalty for extending a gap", seqan3::option_spec::DEFAULT);
+	subparser.add_flag(args.allvsall, 'A', "all-vs-all", "Score every pair of sequences in a fasta/fastq file, optionally gzip-compressed", seqan3::option_spec::DEFAULT);
+	subparser.add_option(args.fileout, 'o', "output", "Output tsv file (all-vs-all)", seqan3::option_spec::DEFAULT);
+	subparser.add_option(args.threads, 't', "threads", "Number of threads (all-vs-all)", seqan3::option_spec::DEFAULT, seqan3::arithmetic_range_validator{1, 1024});
+	subparser.add_option(args.minscore, 's', "min-score", "Report only pairs scoring at least this. Pairs that cannot reach it are not aligned (all-vs-all)", seqan3::option_spec::DEFAULT);
+	subparser.add_option(args.kmer, 'k', "kmer", "K-mer length of the prefilter, 0 to disable (all-vs-all)", seqan3::option_spec::DEFAULT, seqan3::arithmetic_range_validator{0, 31});
+	subparser.add_option(args.minshared, 'c', "min-shared", "Align only pairs sharing at least this many distinct k-mers (all-vs-all)", seqan3::option_spec::DEFAULT, seqan3::arithmetic_range_validator{1, 1000000});
+	subparser.add_option(args.tile, 'T', "tile", "Sequences per side of a tile of the all-vs-all matrix", seqan3::option_spec::DEFAULT, seqan3::arithmetic_range_validator{1, 100000});
+};
+
+
+std::vector<uint64_t> kmer_set(std::vector<seqan3::dna5> const & sequence, int k)
+{
+
+	//sorted distinct k-mers of a sequence, k-mers with N are skipped
+
+	std::vector<uint64_t> kmers;
+	uint64_t mask = (1ULL << 2 * k) - 1, kmer = 0;
+	int l = 0;
+
+	for (seqan3::dna5 c : sequence) {
+
+		uint8_t r = seqan3::to_rank(c);
+		if (r > 3) { l = 0; continue; }
+		kmer = (kmer << 2 | r) & mask;
+		if (++l >= k) kmers.push_back(kmer);
+	}
+
+	std::sort(kmers.begin(), kmers.end());
+	kmers.erase(std::unique(kmers.begin(), kmers.end()), kmers.end());
+	return kmers;
+};
+
+
+size_t shared_kmers(std::vector<uint64_t> const & a, std::vector<uint64_t> const & b, size_t enough)
+{
+	size_t shared = 0;
+
+	for (size_t i = 0, j = 0; i < a.size() && j < b.size() && shared < enough;) {
+
+		if (a[i] < b[j]) ++i;
+		else if (b[j] < a[i]) ++j;
+		else { ++shared; ++i; ++j; }
+	}
+
+	return shared;
+};
+
+
+template <typename config_t>
+int all_vs_all(cmd_arguments_pwalign const & args, config_t const & config)
+{
+
+	//upper triangle of the score matrix, in tiles of tile x tile sequences: a tile reuses the same 2*tile sequences over and over
+	//while they are in cache. The pairs of a tile that pass the prefilter are aligned with a single (vectorised) align_pairwise call,
+	//so that the alignment is set up once per tile. Tiles are scheduled over a work-stealing pool and written out as soon as they are done,
+	//rows within a tile are in (sequence1, sequence2) order
+
+	time_t my_time; 
+	my_time= time(NULL);
+	char *t = ctime(&my_time);
+
+	std::vector<std::string> names;
+	std::vector<std::vector<seqan3::dna5>> sequences;
+	size_t invalid = 0;
+
+	gzFile fp = gzopen(std::filesystem::canonical(args.stringin.front()).string().c_str(), "r");
+	kseq_t *seq = kseq_init(fp);
+
+	while (kseq_read(seq) >= 0) {
+
+		std::vector<seqan3::dna5> sequence {};
+		invalid += encode_dna5(std::string_view(seq->seq.s, seq->seq.l), sequence); //fill vector seq
+		names.push_back(seq->name.s);
+		sequences.push_back(std::move(sequence));
+	}
+
+	kseq_destroy(seq);
+	gzclose(fp);
+
+	if (invalid) {
+
+		t = ctime(&my_time);
+		t[strlen(t)-1] = '\0';
+		std::cout << "[Warning][" <<  t << "] " << invalid << " invalid character/s were read as N" << std::endl;
+	}
+
+	std::vector<std::vector<uint64_t>> kmers;
+	if (args.kmer > 0) for (auto const & sequence : sequences) kmers.push_back(kmer_set(sequence, args.kmer));
+
+	size_t n = sequences.size(), side = (n + args.tile - 1) / args.tile;
+	std::vector<std::pair<size_t, size_t>> tiles;
+	for (size_t ti = 0; ti < side; ++ti) for (size_t tj = ti; tj < side; ++tj) tiles.emplace_back(ti, tj);
+
+	t = ctime(&my_time);
+	t[strlen(t)-1] = '\0';
+	std::cout << "[Message][" <<  t << "] Scoring " << n * (n - (n > 0)) / 2 << " pairs of sequences in " << tiles.size() << " tiles with " << args.threads << " thread/s" << std::endl;
+
+	std::string fout = std::filesystem::absolute(std::filesystem::weakly_canonical(args.fileout).string()).string();
+	std::ofstream os{fout};
+	os << "sequence1\tsequence2\tname1\tname2\tscore\n";
+
+	std::mutex outlock;
+	std::atomic<size_t> aligned {0}, skipped {0};
+	tile_pool pool(args.threads, tiles.size());
+	std::vector<std::thread> workers;
+
+	for (int w = 0; w < args.threads; ++w) {
+
+		workers.emplace_back([&, w]() {
+
+			size_t task;
+			std::string out;
+			std::vector<std::pair<size_t, size_t>> ids;
+			std::vector<int> scores;
+			std::vector<decltype(std::tie(sequences[0], sequences[0]))> batch;
+
+			while (pool.pop(w, task)) {
+
+				size_t ibegin = tiles[task].first * args.tile, jbegin = tiles[task].second * args.tile;
+				size_t iend = std::min(n, ibegin + args.tile), jend = std::min(n, jbegin + args.tile);
+				size_t pruned = 0;
+				out.clear();
+				ids.clear();
+				batch.clear();
+
+				for (size_t i = ibegin; i < iend; ++i) {
+
+					for (size_t j = std::max(jbegin, i + 1); j < jend; ++j) {
+
+						int64_t bound = static_cast<int64_t>(args.match) * std::min(sequences[i].size(), sequences[j].size()); //all matches
+						bool hopeless = bound < args.minscore || (args.kmer > 0 && shared_kmers(kmers[i], kmers[j], args.minshared) < static_cast<size_t>(args.minshared));
+						if (hopeless) { ++pruned; continue; }
+
+						ids.emplace_back(i, j);
+						batch.emplace_back(sequences[i], sequences[j]);
+					}
+				}
+
+				if (!batch.empty()) {
+
+					scores.assign(batch.size(), 0);
+					for (auto const & res : seqan3::align_pairwise(batch, config)) scores[res.sequence1_id()] = res.score(); //results may come out of order
+
+					for (size_t p = 0; p < ids.size(); ++p) {
+
+						auto [i, j] = ids[p];
+						if (scores[p] >= args.minscore) out += std::to_string(i + 1) + "\t" + std::to_string(j + 1) + "\t" + names[i] + "\t" + names[j] + "\t" + std::to_string(scores[p]) + "\n";
+					}
+				}
+
+				aligned += batch.size();
+				skipped += pruned;
+				std::lock_guard<std::mutex> lock(outlock);
+				os << out;
+			}
+		});
+	}
+
+	for (auto & th : workers) th.join();
+
+	t = ctime(&my_time);
+	t[strlen(t)-1] = '\0';
+	std::cout << "[Message][" <<  t << "] Aligned " << aligned << " pairs, skipped " << skipped << " by the prefilter. Results written to " << fout << std::endl;
+
+	t = ctime(&my_time);
+	t[strlen(t)-1] = '\0';
+	std::cout << "[Message][" <<  t << "] Done" << std::endl;
+
+	return 0;
+
 };
 
 
@@ -57,6 +288,30 @@ int pwalign(seqan3::argument_parser & subparser)
 		return -1;
 	}
 
+	if (args.allvsall) {
+
+		if (args.stringin.size() != 1) {
+
+			t = ctime(&my_time);
+			t[strlen(t)-1] = '\0';
+			std::cout << "[Error][" <<  t << "] A single fasta/fastq file must be provided with -A/--all-vs-all. Provided " << args.stringin.size() << " arguments instead" << std::endl;
+			return -1;
+
+		}
+
+		auto scoring_config = seqan3::align_cfg::scoring_scheme{seqan3::nucleotide_scoring_scheme{seqan3::match_score{args.match}, seqan3::mismatch_score{args.mismatch}}} |
+							  seqan3::align_cfg::gap_cost_affine{seqan3::align_cfg::open_score{args.gapopen}, seqan3::align_cfg::extension_score{args.gapextend}} |
+							  seqan3::align_cfg::output_score{} |
+							  seqan3::align_cfg::output_sequence1_id{} |
+							  seqan3::align_cfg::vectorised{};
+
+		if (args.type == "global") return all_vs_all(args, seqan3::align_cfg::method_global{seqan3::align_cfg::free_end_gaps_sequence1_leading{true},
+																							 seqan3::align_cfg::free_end_gaps_sequence2_leading{true},
+																							 seqan3::align_cfg::free_end_gaps_sequence1_trailing{true},
+																							 seqan3::align_cfg::free_end_gaps_sequence2_trailing{true}} | scoring_config);
+		else return all_vs_all(args, seqan3::align_cfg::method_local{} | scoring_config);
+	}
+
 	if (args.stringin.size() != 2) {
 
 		t = ctime(&my_time);
@@ -95,8 +350,8 @@ int pwalign(seqan3::argument_parser & subparser)
 
 	//convert strings to dna5
 
-	for (char c : args.stringin.front()) sequence1.push_back(seqan3::assign_char_to(c, seqan3::dna5{})); //fill vector seq
-	for (char c : args.stringin.back()) sequence2.push_back(seqan3::assign_char_to(c, seqan3::dna5{})); //fill vector seq
+	encode_dna5(args.stringin.front(), sequence1); //fill vector seq
+	encode_dna5(args.stringin.back(), sequence2); //fill vector seq
 
 	//global alignment
 
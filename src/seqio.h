@@ -0,0 +1,115 @@
+#ifndef SEQIO_H
+#define SEQIO_H
+
+#include <zlib.h>
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+//headers
+#include "kseq.h"
+
+
+KSEQ_INIT(gzFile, gzread)
+
+struct seq_record {
+	std::string name;
+	std::string seq;
+	size_t file {0}; //index of the input file the record comes from
+	size_t index {0}; //index of the record across all the input files
+};
+
+struct seq_batch {
+	std::vector<seq_record> records;
+	size_t bases {0};
+};
+
+
+template <typename worker_t>
+void stream_records(std::vector<std::string> const & files, int threads, worker_t && worker, size_t maxrecords = 4096, size_t maxbases = 1 << 24)
+{
+
+	//read fasta/fastq files (optionally gzip-compressed) in a single pass, handing batches of records to "threads" workers.
+	//worker is called as worker(thread id, batch). Reading and processing overlap, and at most 2*threads batches wait in memory
+
+	std::mutex mtx;
+	std::condition_variable not_empty, not_full;
+	std::deque<seq_batch> queue;
+	bool done = false;
+	size_t maxqueue = 2 * static_cast<size_t>(threads);
+
+	std::vector<std::thread> workers;
+
+	for (int w = 0; w < threads; ++w) {
+
+		workers.emplace_back([&, w]() {
+
+			while (true) {
+
+				seq_batch batch;
+
+				{
+				std::unique_lock<std::mutex> lock(mtx);
+				not_empty.wait(lock, [&]{ return !queue.empty() || done; });
+				if (queue.empty()) return; //reader is done and nothing is left
+				batch = std::move(queue.front());
+				queue.pop_front();
+				}
+
+				not_full.notify_one();
+				worker(w, batch);
+			}
+		});
+	}
+
+	auto push = [&](seq_batch & batch) {
+
+		{
+		std::unique_lock<std::mutex> lock(mtx);
+		not_full.wait(lock, [&]{ return queue.size() < maxqueue; });
+		queue.push_back(std::move(batch));
+		}
+
+		not_empty.notify_one();
+		batch = seq_batch{};
+	};
+
+	gzFile fp;
+	kseq_t *seq;
+	seq_batch batch;
+	size_t index = 0;
+
+	for (size_t f = 0; f < files.size(); ++f) {
+
+		fp = gzopen(files[f].c_str(), "r");
+		seq = kseq_init(fp);
+
+		while (kseq_read(seq) >= 0) {
+
+			batch.records.push_back(seq_record{std::string(seq->name.s, seq->name.l), std::string(seq->seq.s, seq->seq.l), f, index++});
+			batch.bases += seq->seq.l;
+
+			if (batch.records.size() >= maxrecords || batch.bases >= maxbases) push(batch);
+		}
+
+		kseq_destroy(seq);
+		gzclose(fp);
+	}
+
+	if (!batch.records.empty()) push(batch);
+
+	{
+	std::lock_guard<std::mutex> lock(mtx);
+	done = true;
+	}
+
+	not_empty.notify_all();
+
+	for (auto & th : workers) th.join();
+
+};
+
+#endif
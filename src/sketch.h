@@ -0,0 +1,403 @@
+#ifndef SKETCH_H
+#define SKETCH_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <cmath>
+#include <atomic>
+#include <memory>
+#include <fstream>
+#include <algorithm>
+#include <filesystem>
+#include <unordered_map>
+#include <seqan3/argument_parser/all.hpp>
+#include <seqan3/core/debug_stream.hpp>
+#include <cereal/archives/binary.hpp>
+#include <cereal/types/vector.hpp>
+#include <cereal/types/string.hpp>
+
+//headers
+#include "seqio.h"
+#include "encode.h"
+
+struct cmd_arguments_sketch {
+	std::vector<std::string> filein{};
+	std::string fileout {"out.sketch"};
+	int kmer {21};
+	int window {10};
+	int scale {1};
+	int threads {1};
+	bool perfile {false};
+};
+
+struct cmd_arguments_screen {
+	std::vector<std::string> filein{};
+	std::string sketchin;
+	std::string fileout {"screen.tsv"};
+	int threads {1};
+	double mincontainment {0.0};
+};
+
+
+struct minimizer_sketch {
+	uint32_t kmer {21};
+	uint32_t window {10};
+	uint64_t maxhash {0};
+	std::vector<std::string> names; //one per reference
+	std::vector<uint64_t> sizes; //distinct minimizers per reference
+	std::vector<uint64_t> hashes; //sorted distinct minimizers across all the references
+	std::vector<uint64_t> offsets; //refs[offsets[i]..offsets[i+1]) are the references containing hashes[i]
+	std::vector<uint32_t> refs;
+
+	template <class Archive>
+	void serialize(Archive & archive)
+	{
+		archive(kmer, window, maxhash, names, sizes, hashes, offsets, refs);
+	}
+};
+
+
+struct hyperloglog {
+
+	//distinct-count estimator for the query minimizers, which are too many to be kept in a set over a whole run
+
+	static constexpr int p = 14;
+	std::vector<uint8_t> registers = std::vector<uint8_t>(1 << p, 0);
+
+	void add(uint64_t h)
+	{
+		h ^= h >> 33; h *= 0xff51afd7ed558ccdULL; h ^= h >> 33; h *= 0xc4ceb9fe1a85ec53ULL; h ^= h >> 33; //minimizers span 2k bits only, spread them to 64
+		uint8_t rank = __builtin_clzll((h << p) | (1ULL << (p - 1))) + 1;
+		uint8_t & r = registers[h >> (64 - p)];
+		if (rank > r) r = rank;
+	}
+
+	void merge(hyperloglog const & other)
+	{
+		for (size_t i = 0; i < registers.size(); ++i) registers[i] = std::max(registers[i], other.registers[i]);
+	}
+
+	double estimate() const
+	{
+		double m = registers.size(), sum = 0;
+		size_t zeros = 0;
+
+		for (uint8_t r : registers) {
+
+			sum += std::ldexp(1.0, -r);
+			if (r == 0) ++zeros;
+		}
+
+		double e = 0.7213 / (1 + 1.079 / m) * m * m / sum;
+		if (e <= 2.5 * m && zeros) e = m * std::log(m / zeros); //linear counting for small cardinalities
+		return e;
+	}
+};
+
+
+uint64_t hash64(uint64_t key, uint64_t mask)
+{
+
+	//invertible integer hash (Thomas Wang) restricted to the 2k bits of a k-mer
+
+	key = (~key + (key << 21)) & mask;
+	key = key ^ key >> 24;
+	key = ((key + (key << 3)) + (key << 8)) & mask;
+	key = key ^ key >> 14;
+	key = ((key + (key << 2)) + (key << 4)) & mask;
+	key = key ^ key >> 28;
+	key = (key + (key << 31)) & mask;
+	return key;
+};
+
+
+void minimizers(std::string const & s, int k, int w, uint64_t maxhash, std::vector<uint64_t> & out)
+{
+
+	//append the (w,k)-minimizers of s to out. K-mers are canonical, so that both strands give the same minimizers, and runs of
+	//ambiguous bases split the sequence. Minimizers above maxhash are dropped (FracMinHash subsampling on top of the minimizers)
+
+	thread_local std::vector<uint8_t> ranks;
+	ranks.resize(s.size());
+	encode_ranks(s.data(), s.size(), ranks.data());
+
+	uint64_t shift = 2 * (k - 1), mask = (1ULL << 2 * k) - 1, kmer[2] = {0, 0};
+	std::deque<std::pair<uint64_t, size_t>> window; //(hash, position), hashes strictly increasing from front to back
+	size_t l = 0, last = SIZE_MAX;
+
+	auto emit = [&]() {
+
+		if (window.front().second != last && window.front().first <= maxhash) out.push_back(window.front().first);
+		last = window.front().second;
+	};
+
+	for (size_t i = 0; i <= s.size(); ++i) {
+
+		int c = (i < s.size()) ? ranks[i] : 4;
+
+		if (c > 3) {
+
+			if (l >= static_cast<size_t>(k) && l < static_cast<size_t>(k + w - 1)) emit(); //run shorter than a full window, keep its best k-mer
+			l = 0;
+			window.clear();
+			continue;
+		}
+
+		kmer[0] = (kmer[0] << 2 | c) & mask;
+		kmer[1] = (kmer[1] >> 2) | static_cast<uint64_t>(3 - c) << shift;
+		if (++l < static_cast<size_t>(k)) continue;
+
+		uint64_t h = hash64(std::min(kmer[0], kmer[1]), mask);
+		while (!window.empty() && window.back().first >= h) window.pop_back();
+		window.emplace_back(h, i);
+		while (window.front().second + w <= i) window.pop_front();
+
+		if (l >= static_cast<size_t>(k + w - 1)) emit();
+	}
+};
+
+
+void initialise_argument_parser_sketch(seqan3::argument_parser & subparser, cmd_arguments_sketch & args)
+{
+	subparser.info.description.push_back("Create a minimizer sketch from fasta/fastq reference file/s, to be used with cuba screen");
+	subparser.add_positional_option(args.filein, "input fastq/fasta file/s, optionally gzip-compressed");
+	subparser.add_option(args.fileout, 'f', "sketch", "output sketch", seqan3::option_spec::DEFAULT);
+	subparser.add_option(args.kmer, 'k', "kmer", "k-mer length", seqan3::option_spec::DEFAULT, seqan3::arithmetic_range_validator{1, 31});
+	subparser.add_option(args.window, 'w', "window", "number of consecutive k-mers a minimizer is picked from", seqan3::option_spec::DEFAULT, seqan3::arithmetic_range_validator{1, 256});
+	subparser.add_option(args.scale, 's', "scale", "keep only 1/scale of the minimizers (FracMinHash). 1 keeps them all", seqan3::option_spec::DEFAULT, seqan3::arithmetic_range_validator{1, 1000000});
+	subparser.add_option(args.threads, 't', "threads", "number of threads", seqan3::option_spec::DEFAULT, seqan3::arithmetic_range_validator{1, 1024});
+	subparser.add_flag(args.perfile, 'p', "per-file", "each input file is a reference (default: each sequence is a reference)", seqan3::option_spec::DEFAULT);
+};
+
+
+void initialise_argument_parser_screen(seqan3::argument_parser & subparser, cmd_arguments_screen & args)
+{
+	subparser.info.description.push_back("Estimate the containment/Jaccard of the references in a minimizer sketch within fasta/fastq file/s");
+	subparser.add_positional_option(args.filein, "input fastq/fasta file/s, optionally gzip-compressed");
+	subparser.add_option(args.sketchin, 'f', "sketch", "input sketch", seqan3::option_spec::REQUIRED);
+	subparser.add_option(args.fileout, 'o', "output", "output tsv file", seqan3::option_spec::DEFAULT);
+	subparser.add_option(args.threads, 't', "threads", "number of threads", seqan3::option_spec::DEFAULT, seqan3::arithmetic_range_validator{1, 1024});
+	subparser.add_option(args.mincontainment, 'c', "containment", "report only references with containment at least this", seqan3::option_spec::DEFAULT, seqan3::arithmetic_range_validator{0, 1});
+};
+
+
+int sketch(seqan3::argument_parser & subparser)
+{
+
+	time_t my_time;
+	my_time= time(NULL);
+	char *t = ctime(&my_time);
+	cmd_arguments_sketch args{};
+	initialise_argument_parser_sketch(subparser, args);
+
+	try
+	{
+		subparser.parse();
+	}
+
+	catch (seqan3::argument_parser_error const & ext)
+	{
+		t = ctime(&my_time);
+		t[strlen(t)-1] = '\0';
+		std::cout << "[Error][" <<  t << "] Wrong command-line argument" << std::endl;
+		seqan3::debug_stream << ext.what() << std::endl;
+		return -1;
+	}
+
+	minimizer_sketch sk{};
+	sk.kmer = args.kmer;
+	sk.window = args.window;
+	sk.maxhash = ((1ULL << 2 * args.kmer) - 1) / args.scale;
+
+	std::vector<std::string> files;
+	std::string skout = std::filesystem::absolute(std::filesystem::weakly_canonical(args.fileout).string()).string();
+
+	for (std::vector<std::string>::const_iterator i = args.filein.begin(); i != args.filein.end(); ++i) {
+
+		files.push_back(std::filesystem::canonical(*i).string());
+		if (args.perfile) sk.names.push_back(std::filesystem::path(*i).filename().string());
+	}
+
+	t = ctime(&my_time);
+	t[strlen(t)-1] = '\0';
+	std::cout << "[Message][" <<  t << "] Collecting minimizers from " << files.size() << " file/s" << std::endl;
+
+	std::mutex mtx;
+	std::vector<std::pair<size_t, std::string>> recnames; //(record index, name), to name the references in input order
+	std::vector<std::pair<uint64_t, uint32_t>> pairs; //(minimizer, reference) over all the references
+
+	stream_records(files, args.threads, [&](int, seq_batch & batch) {
+
+		std::vector<std::pair<uint64_t, uint32_t>> local;
+		std::vector<uint64_t> mins;
+
+		for (seq_record const & rec : batch.records) {
+
+			mins.clear();
+			minimizers(rec.seq, args.kmer, args.window, sk.maxhash, mins);
+			std::sort(mins.begin(), mins.end());
+			mins.erase(std::unique(mins.begin(), mins.end()), mins.end());
+
+			uint32_t ref = static_cast<uint32_t>(args.perfile ? rec.file : rec.index);
+			for (uint64_t h : mins) local.emplace_back(h, ref);
+		}
+
+		std::lock_guard<std::mutex> lock(mtx);
+		pairs.insert(pairs.end(), local.begin(), local.end());
+		if (!args.perfile) for (seq_record const & rec : batch.records) recnames.emplace_back(rec.index, rec.name);
+
+	}, 64);
+
+	if (!args.perfile) {
+
+		std::sort(recnames.begin(), recnames.end());
+		for (auto & p : recnames) sk.names.push_back(std::move(p.second));
+	}
+
+	t = ctime(&my_time);
+	t[strlen(t)-1] = '\0';
+	std::cout << "[Message][" <<  t << "] Building sketch of " << sk.names.size() << " reference/s" << std::endl;
+
+	std::sort(pairs.begin(), pairs.end());
+	pairs.erase(std::unique(pairs.begin(), pairs.end()), pairs.end()); //per-file references may share minimizers across records
+
+	sk.sizes.assign(sk.names.size(), 0);
+	sk.offsets.push_back(0);
+	sk.refs.reserve(pairs.size());
+
+	for (size_t i = 0; i < pairs.size(); ++i) {
+
+		if (i > 0 && pairs[i].first != pairs[i-1].first) sk.offsets.push_back(sk.refs.size());
+		if (i == 0 || pairs[i].first != pairs[i-1].first) sk.hashes.push_back(pairs[i].first);
+		sk.refs.push_back(pairs[i].second);
+		sk.sizes[pairs[i].second]++;
+	}
+
+	sk.offsets.push_back(sk.refs.size());
+	std::vector<std::pair<uint64_t, uint32_t>>().swap(pairs);
+
+	{
+	std::ofstream os{skout, std::ios::binary};
+	cereal::BinaryOutputArchive oarchive{os};
+	oarchive(sk);
+	}
+
+	t = ctime(&my_time);
+	t[strlen(t)-1] = '\0';
+	std::cout << "[Message][" <<  t << "] Stored " << sk.hashes.size() << " distinct minimizers" << std::endl;
+
+	t = ctime(&my_time);
+	t[strlen(t)-1] = '\0';
+	std::cout << "[Message][" <<  t << "] Done" << std::endl;
+
+	return 0;
+
+}
+
+
+int screen(seqan3::argument_parser & subparser)
+{
+
+	time_t my_time;
+	my_time= time(NULL);
+	char *t = ctime(&my_time);
+	cmd_arguments_screen args{};
+	initialise_argument_parser_screen(subparser, args);
+
+	try
+	{
+		subparser.parse();
+	}
+
+	catch (seqan3::argument_parser_error const & ext)
+	{
+		t = ctime(&my_time);
+		t[strlen(t)-1] = '\0';
+		std::cout << "[Error][" <<  t << "] Wrong command-line argument" << std::endl;
+		seqan3::debug_stream << ext.what() << std::endl;
+		return -1;
+	}
+
+	t = ctime(&my_time);
+	t[strlen(t)-1] = '\0';
+	std::cout << "[Message][" <<  t << "] Loading sketch" << std::endl;
+
+	minimizer_sketch sk{};
+
+	{
+	std::ifstream is{std::filesystem::canonical(args.sketchin).string(), std::ios::binary};
+	cereal::BinaryInputArchive iarchive{is};
+	iarchive(sk);
+	}
+
+	std::unordered_map<uint64_t, uint32_t> lookup; //minimizer -> position in sk.hashes
+	lookup.reserve(sk.hashes.size());
+	for (size_t i = 0; i < sk.hashes.size(); ++i) lookup.emplace(sk.hashes[i], static_cast<uint32_t>(i));
+
+	std::unique_ptr<std::atomic<uint8_t>[]> seen(new std::atomic<uint8_t>[sk.hashes.size()]);
+	for (size_t i = 0; i < sk.hashes.size(); ++i) seen[i].store(0, std::memory_order_relaxed);
+
+	std::vector<hyperloglog> hll(args.threads);
+	std::vector<std::string> files;
+	for (std::vector<std::string>::const_iterator i = args.filein.begin(); i != args.filein.end(); ++i) files.push_back(std::filesystem::canonical(*i).string());
+
+	t = ctime(&my_time);
+	t[strlen(t)-1] = '\0';
+	std::cout << "[Message][" <<  t << "] Screening " << files.size() << " file/s against " << sk.names.size() << " reference/s" << std::endl;
+
+	stream_records(files, args.threads, [&](int w, seq_batch & batch) {
+
+		std::vector<uint64_t> mins;
+
+		for (seq_record const & rec : batch.records) {
+
+			mins.clear();
+			minimizers(rec.seq, sk.kmer, sk.window, sk.maxhash, mins);
+
+			for (uint64_t h : mins) {
+
+				hll[w].add(h);
+				auto it = lookup.find(h);
+				if (it != lookup.end()) seen[it->second].store(1, std::memory_order_relaxed);
+			}
+		}
+	});
+
+	for (size_t i = 1; i < hll.size(); ++i) hll[0].merge(hll[i]);
+	double qsize = hll[0].estimate();
+
+	std::vector<uint64_t> shared(sk.names.size(), 0);
+
+	for (size_t i = 0; i < sk.hashes.size(); ++i) {
+
+		if (!seen[i].load(std::memory_order_relaxed)) continue;
+		for (uint64_t j = sk.offsets[i]; j < sk.offsets[i+1]; ++j) shared[sk.refs[j]]++;
+	}
+
+	std::string fout = std::filesystem::absolute(std::filesystem::weakly_canonical(args.fileout).string()).string();
+	std::ofstream os{fout};
+	os << "reference\tshared\tminimizers\tcontainment\tidentity\tjaccard\n";
+
+	for (size_t r = 0; r < sk.names.size(); ++r) {
+
+		double containment = sk.sizes[r] ? static_cast<double>(shared[r]) / sk.sizes[r] : 0.0;
+		if (containment < args.mincontainment) continue;
+		double identity = std::pow(containment, 1.0 / sk.kmer); //k-mer survival under a point-mutation model
+		double jaccard = static_cast<double>(shared[r]) / std::max(1.0, sk.sizes[r] + qsize - shared[r]);
+		os << sk.names[r] << "\t" << shared[r] << "\t" << sk.sizes[r] << "\t" << containment << "\t" << identity << "\t" << jaccard << "\n";
+	}
+
+	t = ctime(&my_time);
+	t[strlen(t)-1] = '\0';
+	std::cout << "[Message][" <<  t << "] Query holds ~" << static_cast<uint64_t>(qsize) << " distinct minimizers. Results written to " << fout << std::endl;
+
+	t = ctime(&my_time);
+	t[strlen(t)-1] = '\0';
+	std::cout << "[Message][" <<  t << "] Done" << std::endl;
+
+	return 0;
+
+}
+
+#endif
@@ -0,0 +1,86 @@
+#ifndef SMEM_H
+#define SMEM_H
+
+#include <vector>
+#include <algorithm>
+#include <seqan3/alphabet/all.hpp>
+
+//super-maximal exact matches (SMEMs) of a query in a bidirectional fm-index, following bwa's smem algorithm: from a query position,
+//extend right as long as possible remembering every point where the number of occurrences drops, then extend all of those left together.
+//A match that cannot be extended left, while no longer one can, is an SMEM. Each round starts where the longest right extension stopped,
+//so the whole query is covered in time linear in its length (times the number of distinct occurrence counts seen along the way)
+
+template <typename cursor_t>
+struct smem_match {
+	cursor_t cursor;
+	uint32_t begin; //0-based, end excluded
+	uint32_t end;
+};
+
+
+template <typename cursor_t, typename query_t>
+uint32_t smem_from(cursor_t const & root, query_t const & query, uint32_t x, uint32_t minlen, std::vector<smem_match<cursor_t>> & out)
+{
+
+	//append the SMEMs containing query[x] to out, return the position the next round starts from
+
+	seqan3::dna5 const n = seqan3::assign_rank_to(4, seqan3::dna5{});
+	std::vector<smem_match<cursor_t>> prev, curr;
+	cursor_t ik = root;
+	uint32_t i = x + 1, len = query.size(), lastbegin = len;
+
+	if (query[x] == n || !ik.extend_right(query[x])) return x + 1;
+
+	for (; i < len && query[i] != n; ++i) { //right extension, keeping the intervals where the count changes
+
+		cursor_t ok = ik;
+		if (!ok.extend_right(query[i])) break;
+		if (ok.count() != ik.count()) curr.push_back(smem_match<cursor_t>{ik, x, i});
+		ik = ok;
+	}
+
+	curr.push_back(smem_match<cursor_t>{ik, x, i});
+	std::reverse(curr.begin(), curr.end()); //longest first
+	std::swap(prev, curr);
+
+	for (int64_t j = static_cast<int64_t>(x) - 1; j >= -1; --j) { //left extension of all of them at once
+
+		bool stop = j < 0 || query[j] == n;
+		curr.clear();
+
+		for (smem_match<cursor_t> const & p : prev) {
+
+			cursor_t ok = p.cursor;
+
+			if (stop || !ok.extend_left(query[j])) {
+
+				//p cannot grow left. It is super-maximal if no longer match survived this round, and not contained in the last one found
+
+				if (curr.empty() && static_cast<uint32_t>(j + 1) < lastbegin) {
+
+					lastbegin = j + 1;
+					if (p.end - lastbegin >= minlen) out.push_back(smem_match<cursor_t>{p.cursor, lastbegin, p.end});
+				}
+
+			} else if (curr.empty() || ok.count() != curr.back().cursor.count()) {
+
+				curr.push_back(smem_match<cursor_t>{ok, p.begin, p.end});
+			}
+		}
+
+		if (curr.empty()) break;
+		std::swap(prev, curr);
+	}
+
+	return i;
+};
+
+
+template <typename index_t, typename query_t>
+void smem_search(index_t const & indexin, query_t const & query, uint32_t minlen, std::vector<smem_match<decltype(indexin.cursor())>> & out)
+{
+	auto root = indexin.cursor();
+	for (uint32_t x = 0; x < query.size();) x = smem_from(root, query, x, minlen, out);
+};
+
+#endif